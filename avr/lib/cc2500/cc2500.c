@@ -1,8 +1,15 @@
 #include <avr/io.h>
 #include "cc2500.h"
-#include <util/delay.h>
+#include "../clk/clk.h"
 #include <avr/pgmspace.h>
 
+#ifdef CC2500_USE_SCHED
+#include "../sched/sched.h"
+#define CC2500_WAIT_US(us) sched_idle_us(us)
+#else
+#define CC2500_WAIT_US(us) clk_delay_us(us)
+#endif
+
 /* CC2500 private function declarations*/
 static void set_chip_select(uint8_t); //SPI chip select logic level
 static void wait_rx_pin_low(void);
@@ -166,7 +173,7 @@ static void CC2500_burst_access(uint8_t addrAND_mode, uint8_t *buffer, uint8_t b
 
 static void set_chip_select(uint8_t pin_value)
 {
-	_delay_us(200);
+	CC2500_WAIT_US(200);
 	
 	if(pin_value)
 	{
@@ -177,7 +184,7 @@ static void set_chip_select(uint8_t pin_value)
 		CC2500_CS_PORT &= ~(1 << CC2500_CS_PIN); //pull CS low
 	}
 	
-	_delay_us(200);
+	CC2500_WAIT_US(200);
 }
 
 
@@ -197,9 +204,9 @@ static inline void chip_reset(void)
 {
 	/* cc2500 reset chip select toggle */
 	CC2500_CS_PORT &= ~(1 << CC2500_CS_PIN); //pull CS low
-	_delay_us(2);
+	clk_delay_short_us(2);
 	CC2500_CS_PORT |= (1 << CC2500_CS_PIN); //pull CS high
-	_delay_us(40);
+	CC2500_WAIT_US(40);
 	
 	CC2500_write_strobe(CC2500_SRES); //reset chip
 	CC2500_write_strobe(CC2500_SIDLE); //set chip in idle state
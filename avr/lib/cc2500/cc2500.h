@@ -2,8 +2,11 @@
 #define CC2500_H_
 
 /******************THIS BLOCK DEFINE HOW DEVICE SHOULD OPERATE***************************/
-/* MCU cpu settings */
-#define F_CPU 1000000UL
+/* MCU cpu settings in avr/lib/clk/clk.h, timing follows the current clock level */
+
+/* Uncomment to idle in scheduler (avr/lib/sched) instead of busy-wait delays.
+   Cpu sleeps but other tasks stay blocked, each SPI access holds the queue about 0.8 ms. */
+//#define CC2500_USE_SCHED
 
 /* CC2500 SPI CS */
 #define CC2500_CS_PIN      PORTB4
@@ -0,0 +1,500 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "cc2500.h"
+#include "cc2500_tdma.h"
+#include "../clk/clk.h"
+#include "../sched/sched.h"
+
+#define TDMA_IOCFG0_SYNC  0x06 //GDO0 asserts on sync word, deasserts at end of packet
+#define TDMA_ADR_CHK      0x02 //PKTCTRL1 address check with 0x00 broadcast
+#define TDMA_WORCTRL_RCPD 0x80 //WORCTRL RC oscillator power down
+#define TDMA_CRC_OK       0x80 //second appended status byte
+#define TDMA_RETRY_COUNTS 125  //queue full, post deadline again after one scheduler tick
+
+/* packet header after length byte */
+#define TDMA_DST 0
+#define TDMA_SRC 1
+#define TDMA_SEQ 2   //beacon sequence number
+#define TDMA_SLOTS 3 //beacon node slot count
+#define TDMA_HEADER 2
+#define TDMA_FIFO_MAX (1 + TDMA_HEADER + TDMA_PAYLOAD_MAX + 2) //length byte, packet, RSSI and LQI/CRC_OK
+
+/* TDMA states */
+#define TDMA_OFF         0
+#define TDMA_ACQUIRE     1 //node listening for any beacon
+#define TDMA_WAIT_SLOT   2 //node radio asleep until own slot
+#define TDMA_IN_SLOT     3 //node transmitting in own slot
+#define TDMA_WAIT_BEACON 4 //node radio asleep until next beacon
+#define TDMA_LISTEN      5 //node listening around expected beacon
+#define TDMA_GATEWAY     6 //gateway sending beacons and receiving
+
+/* CC2500 TDMA private function declarations*/
+static void tdma_timer_start(void);
+static uint32_t tdma_now(void);
+static void tdma_arm(uint32_t deadline);
+static void tdma_fire(void);
+static void tdma_timer_task(void);
+static void tdma_packet_task(void);
+static uint8_t tdma_read_packet(uint8_t *fifo);
+static void tdma_beacon(uint32_t stamp, uint8_t seq, uint8_t slots);
+static void tdma_frame(uint8_t flush);
+static uint32_t tdma_next_frame(void);
+static uint32_t tdma_next_sync(void);
+static void tdma_acquire(void);
+static void tdma_radio_wake(void);
+static void tdma_radio_sleep(uint8_t flush);
+
+/*CC2500 TDMA global variables*/
+static volatile uint16_t tdma_overflows; //Timer1 high word
+static volatile uint32_t tdma_sync_stamp; //last sync word edge
+static volatile uint32_t tdma_packet_stamp; //sync word edge of last complete packet
+static volatile uint32_t tdma_deadline;
+static volatile uint8_t tdma_armed; //deadline pending
+static volatile uint8_t tdma_fired; //deadline passed, tdma_timer_task queued
+static uint8_t tdma_gdo0; //last GDO0 level, pin change interrupt is shared by port B
+
+static uint8_t tdma_state;
+static uint8_t tdma_seq;
+static uint8_t tdma_slots;
+static uint8_t tdma_missed;
+static uint8_t tdma_beacon_sent; //gateway waits for end of own beacon
+static uint32_t tdma_beacon_tx; //gateway beacon task start, own sync word follows within lead time
+static uint32_t tdma_beacon_stamp; //frame start, TDMA_BEACON_LEAD_COUNTS before beacon sync word
+static uint32_t tdma_sync_ref; //sync word of last received beacon
+static uint8_t tdma_sync_seq; //sequence number of last received beacon
+static uint8_t tdma_sync_valid; //tdma_sync_ref taken since last acquire
+static uint32_t tdma_slot_x16; //local slot length in 1/16 timer counts, drift corrected
+static uint32_t tdma_slot_start;
+
+static tdma_tx_cb tdma_tx;
+static tdma_rx_cb tdma_rx;
+
+
+
+ISR(TIMER1_OVF_vect)
+{
+	tdma_overflows++;
+}
+
+
+
+/* GDO0 edge. Timer1 is read first thing, interrupt latency stays a few counts. */
+ISR(PCINT0_vect)
+{
+	uint16_t low = TCNT1;
+	uint16_t high = tdma_overflows;
+	uint8_t gdo0 = TDMA_GDO0_IN & (1 << TDMA_GDO0_PIN);
+
+	if(gdo0 == tdma_gdo0)
+		return; //other port B pin changed
+
+	tdma_gdo0 = gdo0;
+
+	if((TDMA_TIFR & (1 << TOV1)) && low < 0x8000)
+		high++; //read after overflow, overflow interrupt still pending
+
+	if(gdo0) //sync word
+	{
+		tdma_sync_stamp = ((uint32_t)high << 16) | low;
+	}
+	else //end of packet
+	{
+		tdma_packet_stamp = tdma_sync_stamp;
+		sched_post(tdma_packet_task);
+	}
+}
+
+
+
+ISR(TIMER1_COMPA_vect)
+{
+	if(tdma_armed && (int32_t)(tdma_now() - tdma_deadline) >= 0)
+		tdma_fire();
+}
+
+
+
+void CC2500_tdma_node_start(tdma_tx_cb tx)
+{
+	tdma_tx = tx;
+	tdma_slot_x16 = (uint32_t)TDMA_SLOT_COUNTS * 16;
+
+	tdma_timer_start();
+	tdma_acquire();
+}
+
+
+
+void CC2500_tdma_gateway_start(uint8_t slots, tdma_rx_cb rx)
+{
+	tdma_rx = rx;
+	tdma_slots = slots;
+	tdma_state = TDMA_GATEWAY;
+
+	tdma_timer_start();
+	CC2500_write_strobe(CC2500_SIDLE);
+	CC2500_write_strobe(CC2500_SRX);
+
+	tdma_beacon_stamp = tdma_now();
+	tdma_arm(tdma_beacon_stamp);
+}
+
+
+
+uint8_t CC2500_tdma_synced(void)
+{
+	return tdma_state != TDMA_OFF && tdma_state != TDMA_ACQUIRE;
+}
+
+
+
+static void tdma_timer_start(void)
+{
+	CC2500_write_register(CC2500_IOCFG0, TDMA_IOCFG0_SYNC);
+	CC2500_write_register(CC2500_PKTCTRL1, PKTCTRL1 | TDMA_ADR_CHK);
+#if TDMA_SLEEP_STROBE == CC2500_SWOR || TDMA_ACQUIRE_STROBE == CC2500_SWOR
+	CC2500_write_register(CC2500_WORCTRL, WORCTRL & ~TDMA_WORCTRL_RCPD); //WOR needs RC oscillator
+#endif
+
+	/* Timer1 normal mode, free running at CLK_TIMER_HZ */
+	TCCR1A = 0;
+	TCNT1 = 0;
+	tdma_overflows = 0;
+	TDMA_TIFR = (1 << TOV1) | (1 << OCF1A);
+	TDMA_TIMSK |= (1 << TOIE1) | (1 << OCIE1A);
+	TCCR1B = clk_timer_cs();
+
+	/* GDO0 input, pin change interrupt on both edges */
+	TDMA_GDO0_DIR &= ~(1 << TDMA_GDO0_PIN);
+	tdma_gdo0 = TDMA_GDO0_IN & (1 << TDMA_GDO0_PIN);
+	TDMA_PCMSK |= TDMA_GDO0_MASK;
+	TDMA_PCIFR = (1 << PCIF0);
+	TDMA_PCICR |= (1 << PCIE0);
+}
+
+
+
+static uint32_t tdma_now(void)
+{
+	uint16_t low, high;
+	uint8_t sreg = SREG;
+
+	cli();
+	low = TCNT1;
+	high = tdma_overflows;
+	if((TDMA_TIFR & (1 << TOV1)) && low < 0x8000)
+		high++; //overflow interrupt pending
+	SREG = sreg;
+
+	return ((uint32_t)high << 16) | low;
+}
+
+
+
+/* Compare A matches every 65536 counts, ISR posts tdma_timer_task once deadline passed */
+static void tdma_arm(uint32_t deadline)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	tdma_deadline = deadline;
+	OCR1A = (uint16_t)deadline;
+	TDMA_TIFR = (1 << OCF1A);
+	tdma_armed = 1;
+	tdma_fired = 0; //task queued for previous deadline becomes stale
+	SREG = sreg;
+
+	if((int32_t)(tdma_now() - deadline) >= 0) //already passed, compare would wait a full wrap
+	{
+		cli();
+		if(tdma_armed)
+			tdma_fire();
+		SREG = sreg;
+	}
+}
+
+
+
+/* Deadline passed, called with interrupts disabled. Full queue keeps deadline
+   armed and moves compare A close ahead, ISR posts again on that match. */
+static void tdma_fire(void)
+{
+	if(sched_post(tdma_timer_task))
+	{
+		tdma_armed = 0;
+		tdma_fired = 1;
+	}
+	else
+	{
+		OCR1A = TCNT1 + TDMA_RETRY_COUNTS;
+	}
+}
+
+
+
+static void tdma_timer_task(void)
+{
+	uint8_t buffer[TDMA_HEADER + TDMA_PAYLOAD_MAX];
+	uint8_t bytes, fired;
+	uint8_t sreg = SREG;
+
+	cli();
+	fired = tdma_fired;
+	tdma_fired = 0;
+	SREG = sreg;
+
+	if(!fired)
+		return; //deadline was re-armed after this task was queued
+
+	switch(tdma_state)
+	{
+		case TDMA_GATEWAY: //beacon slot
+			tdma_beacon_tx = tdma_now();
+			buffer[TDMA_DST] = TDMA_BROADCAST_ADDR;
+			buffer[TDMA_SRC] = TDMA_GATEWAY_ADDR;
+			buffer[TDMA_SEQ] = ++tdma_seq;
+			buffer[TDMA_SLOTS] = tdma_slots;
+			CC2500_sendRF_payload(buffer, 4); //radio returns to RX after TX, MCSM1
+
+			/* provisional, re-armed from own sync word in tdma_packet_task */
+			tdma_beacon_sent = 1;
+			tdma_beacon_stamp += (uint32_t)(tdma_slots + TDMA_BEACON_SLOTS) * TDMA_SLOT_COUNTS;
+			tdma_arm(tdma_beacon_stamp);
+			break;
+
+		case TDMA_WAIT_SLOT:
+			bytes = tdma_tx(buffer + TDMA_HEADER);
+			if(bytes == 0 || bytes > TDMA_PAYLOAD_MAX) //nothing to send or over the limit, radio stays asleep
+			{
+				tdma_state = TDMA_WAIT_BEACON;
+				tdma_arm(tdma_next_sync() - TDMA_WAKE_COUNTS);
+				break;
+			}
+
+			tdma_radio_wake();
+			buffer[TDMA_DST] = TDMA_GATEWAY_ADDR;
+			buffer[TDMA_SRC] = ADDR;
+			CC2500_sendRF_payload(buffer, bytes + TDMA_HEADER);
+
+			tdma_state = TDMA_IN_SLOT;
+			tdma_arm(tdma_slot_start + TDMA_SLOT_COUNTS - TDMA_GUARD_COUNTS);
+			break;
+
+		case TDMA_IN_SLOT: //radio went to RX after TX, FIFO may hold a packet
+			tdma_radio_sleep(1);
+			tdma_state = TDMA_WAIT_BEACON;
+			tdma_arm(tdma_next_sync() - TDMA_WAKE_COUNTS);
+			break;
+
+		case TDMA_WAIT_BEACON:
+			/* CS low wakes chip, one strobe keeps SPI time out of the wake up.
+			   PATABLE is restored before own slot. */
+			CC2500_write_strobe(CC2500_SRX);
+			tdma_state = TDMA_LISTEN;
+			tdma_arm(tdma_next_sync() + TDMA_DRIFT_COUNTS + TDMA_BEACON_COUNTS);
+			break;
+
+		case TDMA_LISTEN: //beacon missed, continue on predicted timing
+			if(++tdma_missed > TDMA_MAX_MISSED)
+			{
+				tdma_acquire();
+				break;
+			}
+
+			tdma_seq++;
+			tdma_beacon_stamp = tdma_next_frame();
+			tdma_frame(1);
+			break;
+	}
+}
+
+
+
+static void tdma_packet_task(void)
+{
+	uint8_t fifo[TDMA_FIFO_MAX];
+	uint8_t *buffer = fifo + 1;
+	uint8_t bytes;
+	uint32_t stamp;
+	uint8_t sreg = SREG;
+
+	cli(); //32 bit stamp, next sync word edge may interrupt the copy
+	stamp = tdma_packet_stamp;
+	SREG = sreg;
+
+	/* GDO0 also marks own beacon in TX. Gateway frame is referenced to its sync word
+	   the same way nodes reference theirs, so slot timing agrees on both sides.
+	   Packet task for own beacon may have been dropped on a full queue, a later
+	   sync word is a node packet and the provisional frame stays. */
+	if(tdma_state == TDMA_GATEWAY && tdma_beacon_sent)
+	{
+		tdma_beacon_sent = 0;
+
+		if(stamp - tdma_beacon_tx <= 2 * TDMA_BEACON_LEAD_COUNTS)
+		{
+			tdma_beacon_stamp = stamp - TDMA_BEACON_LEAD_COUNTS
+								+ (uint32_t)(tdma_slots + TDMA_BEACON_SLOTS) * TDMA_SLOT_COUNTS;
+			tdma_arm(tdma_beacon_stamp);
+			return;
+		}
+	}
+
+	bytes = tdma_read_packet(fifo);
+	if(bytes < TDMA_HEADER)
+		return;
+
+	if(buffer[TDMA_DST] == TDMA_BROADCAST_ADDR && buffer[TDMA_SRC] == TDMA_GATEWAY_ADDR
+	   && bytes == 4)
+	{
+		if(tdma_state == TDMA_ACQUIRE || tdma_state == TDMA_LISTEN)
+			tdma_beacon(stamp, buffer[TDMA_SEQ], buffer[TDMA_SLOTS]);
+	}
+	else if(tdma_state == TDMA_GATEWAY && buffer[TDMA_DST] == TDMA_GATEWAY_ADDR)
+	{
+		tdma_rx(buffer[TDMA_SRC], buffer + TDMA_HEADER, bytes - TDMA_HEADER);
+	}
+}
+
+
+
+/* Reads RX FIFO in one burst, packet follows length byte at fifo + 1.
+   Two SPI accesses keep beacon handling inside slot 0.
+   returns packet length, 0 if none, CRC failed or more than one packet */
+static uint8_t tdma_read_packet(uint8_t *fifo)
+{
+	uint8_t rxbytes = CC2500_read_status_register(CC2500_RXBYTES);
+	uint8_t bytes;
+
+	if(rxbytes == 0)
+		return 0;
+
+	if(rxbytes <= TDMA_FIFO_MAX) //no overflow, fits buffer
+	{
+		CC2500_read_burst(CC2500_FIFO, fifo, rxbytes);
+
+		bytes = fifo[0];
+		if(bytes + 3 == rxbytes) //length byte, packet and 2 status bytes, PKTCTRL1 APPEND_STATUS
+			return (fifo[bytes + 2] & TDMA_CRC_OK) ? bytes : 0;
+	}
+
+	CC2500_write_strobe(CC2500_SIDLE);
+	CC2500_write_strobe(CC2500_SFRX);
+	CC2500_write_strobe(CC2500_SRX);
+	return 0;
+}
+
+
+
+/* Node received beacon. Beacon interval corrects local slot length for clock drift.
+   Acquire keeps listening until two beacons gave a slot length, sync is never
+   taken on the nominal slot length alone. */
+static void tdma_beacon(uint32_t stamp, uint8_t seq, uint8_t slots)
+{
+	uint8_t frames = seq - tdma_sync_seq;
+	uint8_t valid = 0;
+	int32_t measured = 0, nominal = (int32_t)TDMA_SLOT_COUNTS * 16;
+
+	/* slot length measured since last received beacon, missed beacons included */
+	if(tdma_sync_valid && slots == tdma_slots && frames && frames <= TDMA_MAX_MISSED + 1)
+	{
+		measured = (int32_t)(((stamp - tdma_sync_ref) * 16) / ((uint32_t)frames * (slots + TDMA_BEACON_SLOTS)));
+		valid = measured > nominal - nominal / TDMA_DRIFT_LIMIT && measured < nominal + nominal / TDMA_DRIFT_LIMIT;
+	}
+
+	tdma_sync_ref = stamp;
+	tdma_sync_seq = seq;
+	tdma_sync_valid = 1;
+	tdma_slots = slots;
+
+	if(tdma_state == TDMA_ACQUIRE)
+	{
+		if(!valid)
+			return; //radio stays in RX for next beacon, MCSM1
+
+		tdma_slot_x16 = measured; //first measurement taken as is
+	}
+	else if(valid)
+	{
+		tdma_slot_x16 += (measured - (int32_t)tdma_slot_x16) / TDMA_DRIFT_FILTER;
+	}
+
+	tdma_seq = seq;
+	tdma_missed = 0;
+	tdma_beacon_stamp = stamp - TDMA_BEACON_LEAD_COUNTS;
+	tdma_frame(0); //FIFO just emptied
+}
+
+
+
+/* Schedule own slot or next beacon from frame reference. Slot 0 spans TDMA_BEACON_SLOTS. */
+static void tdma_frame(uint8_t flush)
+{
+	tdma_radio_sleep(flush);
+
+	if(ADDR <= tdma_slots)
+	{
+		tdma_slot_start = tdma_beacon_stamp + ((uint32_t)(TDMA_BEACON_SLOTS - 1 + ADDR) * tdma_slot_x16 >> 4);
+		tdma_state = TDMA_WAIT_SLOT;
+		tdma_arm(tdma_slot_start);
+	}
+	else //no slot assigned in this frame
+	{
+		tdma_state = TDMA_WAIT_BEACON;
+		tdma_arm(tdma_next_sync() - TDMA_WAKE_COUNTS);
+	}
+}
+
+
+
+/* Start of next frame, drift corrected */
+static uint32_t tdma_next_frame(void)
+{
+	return tdma_beacon_stamp + ((uint32_t)(tdma_slots + TDMA_BEACON_SLOTS) * tdma_slot_x16 >> 4);
+}
+
+
+
+/* Expected sync word of next beacon */
+static uint32_t tdma_next_sync(void)
+{
+	return tdma_next_frame() + TDMA_BEACON_LEAD_COUNTS;
+}
+
+
+
+static void tdma_acquire(void)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	tdma_armed = 0;
+	tdma_fired = 0;
+	SREG = sreg;
+
+	tdma_state = TDMA_ACQUIRE;
+	tdma_missed = 0;
+	tdma_sync_valid = 0; //slot length is measured again before sync
+
+	tdma_radio_wake();
+	CC2500_write_strobe(CC2500_SFRX);
+	CC2500_write_strobe(TDMA_ACQUIRE_STROBE);
+}
+
+
+
+static void tdma_radio_wake(void)
+{
+	CC2500_write_strobe(CC2500_SIDLE); //CS low wakes chip, waits for SO low
+	CC2500_write_register(CC2500_PATABLE, PWR_SELECT); //PATABLE is lost in SLEEP
+}
+
+
+
+/* flush 0 saves an SPI access when RX FIFO is known empty */
+static void tdma_radio_sleep(uint8_t flush)
+{
+	CC2500_write_strobe(CC2500_SIDLE);
+	if(flush)
+		CC2500_write_strobe(CC2500_SFRX);
+	CC2500_write_strobe(TDMA_SLEEP_STROBE);
+}
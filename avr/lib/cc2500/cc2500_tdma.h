@@ -0,0 +1,100 @@
+#ifndef CC2500_TDMA_H_
+#define CC2500_TDMA_H_
+
+/******************THIS BLOCK DEFINE HOW TDMA SHOULD OPERATE***************************/
+/* Frame layout. Slot 0 carries the gateway beacon, node transmits in slot ADDR.
+   Timer1 counts at CLK_TIMER_HZ, 8 us per count. A node slot must hold task latency,
+   7 SPI accesses (wake, SIDLE, SFTX, length, burst, STX), calibration, preamble,
+   full packet airtime and TDMA_GUARD_COUNTS: 500 + 700 + 102 + 32 + 84 + 250 = 1668. */
+#define TDMA_SLOT_COUNTS    2000  // 16 ms slot
+#define TDMA_GUARD_COUNTS   250   // 2 ms, radio idle at slot end
+#define TDMA_BEACON_COUNTS  500   // 4 ms beacon airtime, listen window after expected beacon
+
+/* Radio wake up before expected beacon sync word, single SRX strobe from SLEEP */
+#define TDMA_SPI_COUNTS      100  // one CC2500 SPI access, set_chip_select waits 4 x 200 us
+#define TDMA_XOSC_COUNTS     20   // crystal start from SLEEP, about 150 us
+#define TDMA_CAL_COUNTS      102  // synthesizer calibration on IDLE -> RX, about 810 us
+#define TDMA_PREAMBLE_COUNTS 32   // 4 byte preamble and 4 byte sync at 250 kBaud, MDMCFG1
+#define TDMA_TASK_MAX_COUNTS 500  // 4 ms, longest other task on the node, e.g. one LCD row at 1 MHz.
+								  // sched_idle_us does not yield, run hd44780u_init before TDMA starts.
+#define TDMA_DRIFT_COUNTS    125  // 1 ms, beacon timing error left after drift correction
+#define TDMA_MARGIN_COUNTS   (TDMA_TASK_MAX_COUNTS + TDMA_DRIFT_COUNTS)  // task latency and drift
+#define TDMA_WAKE_COUNTS     (TDMA_SPI_COUNTS + TDMA_XOSC_COUNTS + TDMA_CAL_COUNTS \
+							  + TDMA_PREAMBLE_COUNTS + TDMA_MARGIN_COUNTS)
+
+/* Frame starts this long before beacon sync word: gateway beacon task SIDLE, SFTX,
+   length, burst and STX accesses, calibration, preamble and sync. Slot 0 must hold it. */
+#define TDMA_BEACON_LEAD_COUNTS (5 * TDMA_SPI_COUNTS + TDMA_CAL_COUNTS + TDMA_PREAMBLE_COUNTS)
+
+/* Node work in slot 0 after the beacon, longest on a missed beacon: listen window end,
+   task latency, SIDLE, SFRX and sleep strobe. A received beacon needs less, end of packet,
+   task latency, RXBYTES and FIFO burst, SIDLE and sleep strobe: 28 + 500 + 400.
+   634 + 125 + 500 + 500 + 300 = 2059, slot 0 spans 2 slots. */
+#define TDMA_BEACON_BUDGET_COUNTS (TDMA_BEACON_LEAD_COUNTS + TDMA_DRIFT_COUNTS + TDMA_BEACON_COUNTS \
+								   + TDMA_TASK_MAX_COUNTS + 3 * TDMA_SPI_COUNTS)
+#define TDMA_BEACON_SLOTS ((TDMA_BEACON_BUDGET_COUNTS + TDMA_SLOT_COUNTS - 1) / TDMA_SLOT_COUNTS)
+
+#define TDMA_MAX_MISSED     3     // beacons predicted from drift before resynchronizing
+#define TDMA_DRIFT_FILTER   4     // slot length correction = error / TDMA_DRIFT_FILTER
+#define TDMA_DRIFT_LIMIT    4     // slot length off by slot length / 4 is rejected, both ends run on +-10% RC
+
+/* Addressing. Gateway builds set ADDR to TDMA_GATEWAY_ADDR, nodes use ADDR 1 - 254.
+   Beacons are sent to broadcast address 0x00. */
+#define TDMA_GATEWAY_ADDR   0xFF
+#define TDMA_BROADCAST_ADDR 0x00
+#define TDMA_PAYLOAD_MAX    16
+#define TDMA_PACKET_COUNTS  ((5 + TDMA_PAYLOAD_MAX) * 4) // length, header, payload and CRC at 250 kBaud
+
+#if TDMA_TASK_MAX_COUNTS + 7 * TDMA_SPI_COUNTS + TDMA_CAL_COUNTS + TDMA_PREAMBLE_COUNTS \
+	+ TDMA_PACKET_COUNTS + TDMA_GUARD_COUNTS > TDMA_SLOT_COUNTS
+#error "TDMA_SLOT_COUNTS too short for a full node packet"
+#endif
+
+/* Radio between slots: CC2500_SPWD or CC2500_SWOR.
+   Radio while looking for beacons: CC2500_SRX or CC2500_SWOR, WOREVT/WORCTRL/MCSM2 set polling. */
+#define TDMA_SLEEP_STROBE   CC2500_SPWD
+#define TDMA_ACQUIRE_STROBE CC2500_SRX
+
+/* GDO0 input, edges are timestamped from Timer1 in a pin change interrupt.
+   Not ICP1 or INT0/INT1: on ATtiny4313 they are PD6, PD2 and PD3, used by the HD44780U
+   (RW, D2, D3). GDO0 must be on port B, away from CC2500 CS and the USI pins PB5-PB7,
+   and no other pin change interrupt of port B may run long. */
+#define TDMA_GDO0_PIN  PINB3
+#define TDMA_GDO0_IN   PINB
+#define TDMA_GDO0_DIR  DDRB
+#define TDMA_GDO0_MASK (1 << PCINT3)
+
+/* Timer1 and pin change interrupt registers differ between tiny and mega parts. */
+#ifdef TIMSK1
+#define TDMA_TIMSK TIMSK1
+#define TDMA_TIFR  TIFR1
+#else
+#define TDMA_TIMSK TIMSK
+#define TDMA_TIFR  TIFR
+#endif
+
+#ifdef PCICR
+#define TDMA_PCICR PCICR
+#define TDMA_PCIFR PCIFR
+#define TDMA_PCMSK PCMSK0
+#else
+#define TDMA_PCICR GIMSK
+#define TDMA_PCIFR GIFR
+#define TDMA_PCMSK PCMSK
+#endif
+
+/* Node callback, fills at most TDMA_PAYLOAD_MAX payload bytes to send in own slot.
+   returns payload length, 0 to skip slot. Longer lengths are not sent. */
+typedef uint8_t (*tdma_tx_cb)(uint8_t *payload);
+
+/* Gateway callback, called for every node packet received. */
+typedef void (*tdma_rx_cb)(uint8_t src, uint8_t *payload, uint8_t bytes);
+/****************************************************************************************/
+
+/*--------CC2500 TDMA function declarations--------*/
+/* CC2500_init and sched_init must be called first. */
+extern void CC2500_tdma_node_start(tdma_tx_cb tx); //listen for beacons, then send in slot ADDR
+extern void CC2500_tdma_gateway_start(uint8_t slots, tdma_rx_cb rx); //send beacons for slots nodes
+extern uint8_t CC2500_tdma_synced(void); //node follows gateway beacons
+
+#endif /* CC2500_TDMA_H_ */
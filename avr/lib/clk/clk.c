@@ -0,0 +1,111 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/power.h>
+#include <util/delay_basic.h>
+#include "clk.h"
+
+#if CLK_F_MAX % 4000000UL
+#error "CLK_F_MAX must be a multiple of 4 MHz"
+#endif
+
+#define CLK_TIMER_CS_MASK ((1 << CS02) | (1 << CS01) | (1 << CS00)) //same bits in TCCR1B
+
+/* clock level tables, indexed by CLK_FAST, CLK_NORMAL, CLK_SLOW */
+static const uint8_t clk_shift_table[] = { clock_div_1, clock_div_8, clock_div_64 };
+static const uint8_t clk_timer_cs_table[] =
+{
+	(1 << CS01) | (1 << CS00), //timer /64
+	(1 << CS01),               //timer /8
+	(1 << CS00),               //timer /1
+};
+
+
+
+
+uint8_t clk_set(uint8_t level)
+{
+	uint8_t previous = clk_level();
+	uint8_t shift, timer_cs;
+	uint8_t sreg = SREG;
+
+#if CLK_VCC_MIN_MV < 2700
+	if(level == CLK_FAST)
+		level = CLK_NORMAL; //8 MHz out of safe operating area
+#endif
+
+	shift = clk_shift_table[level];
+	timer_cs = clk_timer_cs_table[level];
+
+	cli();
+
+	/* avr-libc does the timed CLKPCE sequence in asm, safe at any optimization level */
+	clock_prescale_set((clock_div_t)shift);
+
+	/* keep running timers at CLK_TIMER_HZ */
+	if(TCCR0B & CLK_TIMER_CS_MASK)
+		TCCR0B = (TCCR0B & ~CLK_TIMER_CS_MASK) | timer_cs;
+
+	if(TCCR1B & CLK_TIMER_CS_MASK)
+		TCCR1B = (TCCR1B & ~CLK_TIMER_CS_MASK) | timer_cs;
+
+	SREG = sreg;
+
+	return previous;
+}
+
+
+
+uint8_t clk_level(void)
+{
+	uint8_t shift = clk_get_shift();
+
+	if(shift < 3)
+		return CLK_FAST;
+
+	if(shift < 6)
+		return CLK_NORMAL;
+
+	return CLK_SLOW;
+}
+
+
+
+/* Divider comes from CLKPR, CKDIV8 fuse decides boot value */
+uint8_t clk_get_shift(void)
+{
+	return CLKPR & 0x0F;
+}
+
+
+
+uint8_t clk_timer_cs(void)
+{
+	return clk_timer_cs_table[clk_level()];
+}
+
+
+
+void clk_delay_us(uint16_t us)
+{
+	/* _delay_loop_2 takes 4 cycles per loop */
+	uint32_t loops = ((uint32_t)us * (CLK_F_MAX / 4000000UL)) >> clk_get_shift();
+
+	while(loops > 0xFFFF)
+	{
+		_delay_loop_2(0); //0 runs 65536 loops
+		loops -= 0x10000;
+	}
+
+	if(loops)
+		_delay_loop_2(loops);
+}
+
+
+
+void clk_delay_ms(uint16_t ms)
+{
+	while(ms--)
+	{
+		clk_delay_us(1000);
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef CLK_H_
+#define CLK_H_
+
+/******************THIS BLOCK DEFINE HOW CLOCK SHOULD OPERATE***************************/
+/* MCU cpu settings, internal RC oscillator before clock prescaler */
+#define CLK_F_MAX 8000000UL
+
+/* Lowest supply voltage of the board. 8 MHz needs 2.7 V or more (datasheet speed grade),
+   below that clk_set runs CLK_FAST requests at CLK_NORMAL. */
+#define CLK_VCC_MIN_MV 2700
+
+/* Clock levels. Timer0 and Timer1 keep counting at CLK_TIMER_HZ on every level. */
+#define CLK_FAST   0 // 8 MHz, VCC >= 2.7 V, burst work: FIFO transfers, LCD flushes, formatting
+#define CLK_NORMAL 1 // 1 MHz, boot default with CKDIV8 fuse programmed
+#define CLK_SLOW   2 // 125 kHz, idle
+
+#define CLK_TIMER_HZ 125000UL
+/****************************************************************************************/
+
+/*--------clock function declarations--------*/
+/* Switch core clock level and retune running timers. Returns previous level so burst
+   work can restore it: prev = clk_set(CLK_FAST); ... clk_set(prev);
+   Must not be called from an ISR that can interrupt a clk_delay_us. */
+extern uint8_t clk_set(uint8_t level);
+extern uint8_t clk_level(void); //current clock level
+extern uint8_t clk_get_shift(void); //log2 of current division from CLK_F_MAX, read from CLKPR
+extern uint8_t clk_timer_cs(void); //Timer0/Timer1 clock select bits giving CLK_TIMER_HZ
+
+/* Busy-wait scaled to the current clock. Waits are never shorter than requested. */
+extern void clk_delay_us(uint16_t us);
+extern void clk_delay_ms(uint16_t ms);
+
+/* Busy-wait for setup and pulse timings of a few microseconds, like _delay_us.
+   us must be a compile-time constant, each clock level gets its own cycle count
+   and no call is made. Unknown dividers wait as long as at CLK_FAST. */
+static inline __attribute__((always_inline)) void clk_delay_short_us(double us)
+{
+	switch(CLKPR & 0x0F)
+	{
+		case 3: //CLK_NORMAL
+			__builtin_avr_delay_cycles((uint32_t)__builtin_ceil((CLK_F_MAX >> 3) / 1e6 * us));
+			break;
+
+		case 6: //CLK_SLOW
+			__builtin_avr_delay_cycles((uint32_t)__builtin_ceil((CLK_F_MAX >> 6) / 1e6 * us));
+			break;
+
+		default:
+			__builtin_avr_delay_cycles((uint32_t)__builtin_ceil(CLK_F_MAX / 1e6 * us));
+			break;
+	}
+}
+
+#endif /* CLK_H_ */
@@ -1,7 +1,16 @@
 #include <avr/io.h>
 #include <avr/pgmspace.h>
-#include <util/delay.h>
 #include "hd44780u.h"
+#include "../clk/clk.h"
+
+#ifdef HD44780U_USE_SCHED
+#include "../sched/sched.h"
+#define HD44780U_WAIT_US(us) sched_idle_us(us)
+#define HD44780U_WAIT_MS(ms) sched_idle_ms(ms)
+#else
+#define HD44780U_WAIT_US(us) clk_delay_us(us)
+#define HD44780U_WAIT_MS(ms) clk_delay_ms(ms)
+#endif
 
 #define ASCII_NUMBER_OFFSET 0x30
 #define ASCII_LETTER_OFFSET 0x37
@@ -9,6 +18,10 @@
 static uint8_t hd44780u_prepareIOContents(uint8_t nibble);
 static uint8_t hd44780u_isBusy(void);
 static void hd44780u_toggleEnable(void);
+static void hd44780u_vlinePut(const hd44780u_vline *vlines, uint8_t count, uint8_t column);
+
+static uint8_t hd44780u_viewStart;  //virtual column shown at leftmost visible cell
+static uint8_t hd44780u_ddramStart; //first virtual column currently held in DDRAM
 
 /*
 * Function: hd44780u_init
@@ -27,7 +40,7 @@ void hd44780u_init(void)
 	HD44780U_COMMANDDIR |= (1 << RS) | (1 << RW) | (1 << EN);
 
 	//START controller init procedure. check flowchart at HD4470 datasheet Figure 24 4-Bit Interface page 46
-	_delay_ms(50);
+	HD44780U_WAIT_MS(50);
 	hd44780u_command(0x33);//lcd init
 	hd44780u_command(0x32);//lcd init
 	hd44780u_command(0x28);//4-bit bus mode + 2 line/5*8dots display set
@@ -46,7 +59,7 @@ void hd44780u_command(uint8_t command)
 {
 	while(hd44780u_isBusy())
 	{
-		_delay_us(40);
+		HD44780U_WAIT_US(40);
 	}
 
 	HD44780U_DATAPORT &= ~ ((1 << D3) | (1 << D2) | (1 << D1) | (1 << D0)); //clear io datalines
@@ -73,7 +86,7 @@ void hd44780u_write(uint8_t data)
 {
 	while(hd44780u_isBusy())
 	{
-		_delay_us(40);
+		HD44780U_WAIT_US(40);
 	}
 
 	HD44780U_DATAPORT &= ~ ((1 << D3) | (1 << D2) | (1 << D1) | (1 << D0)); //clear io datalines
@@ -111,14 +124,17 @@ void hd44780u_putString(const char *strPtr)
 */
 void hd44780u_clear(void)
 {
-	hd44780u_command(CLEAR);
-	hd44780u_command(RETURN_HOME);
+	hd44780u_command(HD44780U_CLEAR);
+	hd44780u_command(HD44780U_RETURN_HOME);
+	hd44780u_viewStart = 0;//display shift is cancelled
+	hd44780u_ddramStart = 0;
 }
 
 /*
 * Function: hd44780u_gotoXY
 * ----------------------------
 * Moves controller lcd cursor to given location.
+* On 1 and 2 row modules location is relative to the visible window after virtual line scrolling.
 * x: horizontal cursor pos
 * y: vertical cursor pos
 */
@@ -128,7 +144,11 @@ void hd44780u_gotoXY(uint8_t x, uint8_t y)
 	#if LCD_ROWS > 4
 	#error "over 4 row lcd not supported"
 	#endif
+	#if LCD_ROWS > 2
 	hd44780u_command(lines[y] + x);
+	#else
+	hd44780u_command(lines[y] + (hd44780u_viewStart + x) % LCD_DDRAM_COLUMNS);//display shift moves every row
+	#endif
 }
 
 /*
@@ -154,6 +174,113 @@ void hd44780u_putHexByte(uint8_t hexByte)
 	hd44780u_write(lower);
 }
 
+/*
+* Function: hd44780u_gotoDDRAM
+* ----------------------------
+* Moves controller address counter to given DDRAM location regardless of display shift.
+* x: DDRAM column, 0 - (LCD_DDRAM_COLUMNS - 1)
+* y: DDRAM line
+*/
+void hd44780u_gotoDDRAM(uint8_t x, uint8_t y)
+{
+	hd44780u_command(0x80 | (y ? 0x40 : 0x00) | x);//0x80 + DDRAM line start address 0x00 or 0x40
+}
+
+/*
+* Function: hd44780u_vlineLoad
+* ----------------------------
+* Resets display shift and fills DDRAM with the first LCD_DDRAM_COLUMNS characters of each virtual line.
+* vlines: virtual lines, one per row at most.
+* count: number of virtual lines.
+*/
+void hd44780u_vlineLoad(const hd44780u_vline *vlines, uint8_t count)
+{
+	uint8_t column;
+
+	hd44780u_command(HD44780U_RETURN_HOME);//return home also cancels display shift
+	hd44780u_viewStart = 0;
+	hd44780u_ddramStart = 0;
+
+	while(count--)
+	{
+		hd44780u_gotoDDRAM(0, vlines->row);
+		for(column = 0; column < LCD_DDRAM_COLUMNS; column++)
+		{
+			hd44780u_write(column < vlines->length ? pgm_read_byte(vlines->text + column) : ' ');
+		}
+		vlines++;
+	}
+}
+
+/*
+* Function: hd44780u_scrollLeft
+* ----------------------------
+* Moves visible window one column right along the virtual lines with a single display shift command.
+* DDRAM is rewritten only when a character outside of the loaded DDRAM area comes into view.
+* vlines: same virtual lines given to hd44780u_vlineLoad.
+* count: number of virtual lines.
+*/
+void hd44780u_scrollLeft(const hd44780u_vline *vlines, uint8_t count)
+{
+	if(hd44780u_viewStart + LCD_COLUMNS >= 0xFF)
+		return;//end of virtual column range
+
+	hd44780u_viewStart++;
+
+	//incoming column is outside of DDRAM, reuse the column that scrolled out of view longest ago
+	if(hd44780u_viewStart + LCD_COLUMNS > hd44780u_ddramStart + LCD_DDRAM_COLUMNS)
+	{
+		hd44780u_vlinePut(vlines, count, hd44780u_ddramStart + LCD_DDRAM_COLUMNS);
+		hd44780u_ddramStart++;
+	}
+
+	hd44780u_command(HD44780U_SHIFT_ENTIRE_DISP_LEFT);
+}
+
+/*
+* Function: hd44780u_scrollRight
+* ----------------------------
+* Moves visible window one column left along the virtual lines with a single display shift command.
+* DDRAM is rewritten only when a character outside of the loaded DDRAM area comes into view.
+* vlines: same virtual lines given to hd44780u_vlineLoad.
+* count: number of virtual lines.
+*/
+void hd44780u_scrollRight(const hd44780u_vline *vlines, uint8_t count)
+{
+	if(hd44780u_viewStart == 0)
+		return;//already at virtual line start
+
+	hd44780u_viewStart--;
+
+	//incoming column is outside of DDRAM, reuse the column that scrolled out of view longest ago
+	if(hd44780u_viewStart < hd44780u_ddramStart)
+	{
+		hd44780u_ddramStart--;
+		hd44780u_vlinePut(vlines, count, hd44780u_ddramStart);
+	}
+
+	hd44780u_command(HD44780U_SHIFT_ENTIRE_DISP_RIGHT);
+}
+
+/*
+* Function: hd44780u_vlinePut
+* ----------------------------
+* Writes one virtual column of every virtual line to its DDRAM location.
+* Column must not be visible, so it is written before the display is shifted.
+* vlines: virtual lines.
+* count: number of virtual lines.
+* column: virtual column to write.
+*/
+static void hd44780u_vlinePut(const hd44780u_vline *vlines, uint8_t count, uint8_t column)
+{
+	while(count--)
+	{
+		hd44780u_gotoDDRAM(column % LCD_DDRAM_COLUMNS, vlines->row);
+		hd44780u_write(column < vlines->length ? pgm_read_byte(vlines->text + column) : ' ');
+		vlines++;
+	}
+}
+
 /*
 * Function: hd44780u_toggleEnable
 * ----------------------------
@@ -161,11 +288,11 @@ void hd44780u_putHexByte(uint8_t hexByte)
 */
 static void hd44780u_toggleEnable(void)
 {
-	_delay_us(1);//wait for signals to set up
-	LCD_COMMANDPORT |= (1 << EN);// 1 for enable
-	_delay_us(2);//wider pulse
+	clk_delay_short_us(1);//wait for signals to set up
+	HD44780U_COMMANDPORT |= (1 << EN);// 1 for enable
+	clk_delay_short_us(2);//wider pulse
 	HD44780U_COMMANDPORT &= ~ (1 << EN);//Enable 0
-	_delay_us(1);//wait for LCD to acknowledge disable
+	clk_delay_short_us(1);//wait for LCD to acknowledge disable
 }
 
 /*
@@ -185,13 +312,13 @@ static uint8_t hd44780u_isBusy(void)
 	HD44780U_COMMANDPORT |=   (1 << RW);// 1 for read
 
 	//capture high nibble
-	_delay_us(1);//wait for data to set up
+	clk_delay_short_us(1);//wait for data to set up
 	HD44780U_COMMANDPORT |= (1 << EN);// 1 for enable
-	_delay_us(2);//wider pulse
+	clk_delay_short_us(2);//wider pulse
 	if(HD44780U_DATAREAD & (1 << D3))
         returnable = 1;//set BusyFlag
 	HD44780U_COMMANDPORT &= ~ (1 << EN);//Enable 0
-	_delay_us(1);//wait for data to set up
+	clk_delay_short_us(1);//wait for data to set up
 	//end of capture high nibble
 
 	//discard low nibble
@@ -19,9 +19,14 @@
 #define D3 3
 //LCD I/O port&pin definitions
 
+//Uncomment to idle in scheduler (avr/lib/sched) instead of busy-wait delays.
+//Cpu sleeps but other tasks stay blocked: at 1 MHz a full screen write holds the queue about 8 ms, init about 52 ms.
+//#define HD44780U_USE_SCHED
+
 /*LCD properties */
 #define LCD_ROWS 2
 #define LCD_COLUMNS 16
+#define LCD_DDRAM_COLUMNS 40 //DDRAM characters per line in 2 line mode
 
 //Commands definitions
 #define HD44780U_CLEAR					 0x01
@@ -41,6 +46,21 @@
 #define HD44780U_SHIFT_ENTIRE_DISP_RIGHT 0x1C
 //end of LCD commands definitions
 
+/*
+* Type: hd44780u_vline
+* ----------------------------
+* Virtual text line wider than the visible window.
+* text: string of length characters that MUST be pointing to program memory region.
+* length: virtual line length, positions past it are shown as spaces.
+* row: lcd row the line is shown on.
+*/
+typedef struct
+{
+	const char *text;
+	uint8_t length;
+	uint8_t row;
+} hd44780u_vline;
+
 /*
 * Function: hd44780u_init
 * ----------------------------
@@ -77,6 +97,7 @@ void hd44780u_clear(void);
 * Function: hd44780u_gotoXY
 * ----------------------------
 * Moves controller lcd cursor to given location.
+* On 1 and 2 row modules location is relative to the visible window after virtual line scrolling.
 * x: horizontal cursor pos
 * y: vertical cursor pos
 */
@@ -98,4 +119,46 @@ void hd44780u_putHexByte(uint8_t hexByte);
 */
 void hd44780u_command(uint8_t command);
 
+/*
+* Function: hd44780u_gotoDDRAM
+* ----------------------------
+* Moves controller address counter to given DDRAM location regardless of display shift.
+* x: DDRAM column, 0 - (LCD_DDRAM_COLUMNS - 1)
+* y: DDRAM line
+*/
+void hd44780u_gotoDDRAM(uint8_t x, uint8_t y);
+
+/*
+* Function: hd44780u_vlineLoad
+* ----------------------------
+* Resets display shift and fills DDRAM with the first LCD_DDRAM_COLUMNS characters of each virtual line.
+* vlines: virtual lines, one per row at most.
+* count: number of virtual lines.
+*/
+void hd44780u_vlineLoad(const hd44780u_vline *vlines, uint8_t count);
+
+/*
+* Function: hd44780u_scrollLeft
+* ----------------------------
+* Moves visible window one column right along the virtual lines with a single display shift command.
+* DDRAM is rewritten only when a character outside of the loaded DDRAM area comes into view.
+* Display shift moves every row, rows without a virtual line scroll their DDRAM contents too.
+* Characters written with hd44780u_gotoXY on a virtual line row are overwritten when scrolled in again.
+* Virtual lines need 1 or 2 row modules, hd44780u_clear ends scrolling.
+* vlines: same virtual lines given to hd44780u_vlineLoad.
+* count: number of virtual lines.
+*/
+void hd44780u_scrollLeft(const hd44780u_vline *vlines, uint8_t count);
+
+/*
+* Function: hd44780u_scrollRight
+* ----------------------------
+* Moves visible window one column left along the virtual lines with a single display shift command.
+* DDRAM is rewritten only when a character outside of the loaded DDRAM area comes into view.
+* Same row and hd44780u_gotoXY notes as hd44780u_scrollLeft apply.
+* vlines: same virtual lines given to hd44780u_vlineLoad.
+* count: number of virtual lines.
+*/
+void hd44780u_scrollRight(const hd44780u_vline *vlines, uint8_t count);
+
 #endif //HD44780U_H_
@@ -0,0 +1,67 @@
+#include <stdint.h>
+#include <avr/io.h>
+#include "../../clk/clk.h"
+#include "hd44780u_emu.h"
+
+/* Host replacement for avr/lib/clk. Delays advance emulator time by
+   the requested minimum plus the cost of the call instead of spinning. */
+
+volatile uint8_t CLKPR = 3; //CKDIV8 fuse programmed, CLK_NORMAL
+
+static const uint8_t clk_shift_table[] = { 0, 3, 6 };
+
+
+
+uint8_t clk_set(uint8_t level)
+{
+	uint8_t previous = clk_level();
+
+	CLKPR = clk_shift_table[level];
+
+	return previous;
+}
+
+
+
+uint8_t clk_level(void)
+{
+	uint8_t shift = clk_get_shift();
+
+	if(shift < 3)
+		return CLK_FAST;
+
+	if(shift < 6)
+		return CLK_NORMAL;
+
+	return CLK_SLOW;
+}
+
+
+
+uint8_t clk_get_shift(void)
+{
+	return CLKPR & 0x0F;
+}
+
+
+
+uint8_t clk_timer_cs(void)
+{
+	return 0;
+}
+
+
+
+void clk_delay_us(uint16_t us)
+{
+	hd44780u_emuWaitCycles(HD44780U_EMU_DELAY_CALL_CYCLES);
+	hd44780u_emuWaitUs(us);
+}
+
+
+
+void clk_delay_ms(uint16_t ms)
+{
+	hd44780u_emuWaitCycles(HD44780U_EMU_DELAY_CALL_CYCLES);
+	hd44780u_emuWaitUs(ms * 1000UL);
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "../hd44780u.h"
+#include "../../clk/clk.h"
+#include "hd44780u_emu.h"
+
+/*
+* Host benchmark for the hd44780u library running against the emulated module.
+* Reports bus traffic and modeled time per operation. Modeled time counts driver
+* waits and port accesses, not the rest of the MCU instructions.
+* Exits non-zero if the emulated display does not show the expected text.
+*/
+
+#define MARQUEE_STEPS 64
+
+typedef struct
+{
+	hd44780u_emuStats stats;
+	uint64_t timeNs;
+} bench_mark;
+
+static const char rowText[LCD_ROWS][LCD_COLUMNS + 1] PROGMEM =
+{
+	"0123456789ABCDEF",
+	"fedcba9876543210",
+};
+
+static const char marqueeText[] PROGMEM =
+	"Virtual line scrolled across DDRAM by display shift, 80 characters long.........";
+
+static const hd44780u_vline marqueeLines[] =
+{
+	{ marqueeText, sizeof(marqueeText) - 1, 0 },
+};
+
+static uint8_t failures;
+
+static bench_mark bench_start(void)
+{
+	bench_mark mark;
+
+	mark.stats = hd44780u_emuGetStats();
+	mark.timeNs = hd44780u_emuTimeNs();
+
+	return mark;
+}
+
+static void bench_report(const char *name, bench_mark start, uint16_t repeat)
+{
+	hd44780u_emuStats now = hd44780u_emuGetStats();
+	uint64_t busNs = hd44780u_emuTimeNs() - start.timeNs;
+	uint64_t readyNs = hd44780u_emuReadyNs() - start.timeNs;
+
+	printf("%-26s %8.1f %8.1f %9.1f %8.1f %7.1f %10.1f %10.1f\n", name,
+		(double)(now.transactions - start.stats.transactions) / repeat,
+		(double)(now.commands - start.stats.commands) / repeat,
+		(double)(now.dataWrites - start.stats.dataWrites) / repeat,
+		(double)(now.reads - start.stats.reads) / repeat,
+		(double)(now.busyViolations - start.stats.busyViolations) / repeat,
+		busNs / 1000.0 / repeat,
+		readyNs / 1000.0 / repeat);
+}
+
+static void bench_expect(uint8_t row, const char *expected)
+{
+	char shown[LCD_COLUMNS + 1];
+
+	hd44780u_emuRender(row, shown);
+	if(strncmp(shown, expected, LCD_COLUMNS) != 0)
+	{
+		printf("  MISMATCH row %u: shown \"%s\" expected \"%.*s\"\n", row, shown, LCD_COLUMNS, expected);
+		failures++;
+	}
+}
+
+static void bench_window(uint8_t start, char *window)
+{
+	uint8_t i;
+
+	for(i = 0; i < LCD_COLUMNS; i++)
+	{
+		uint8_t column = start + i;
+		window[i] = column < sizeof(marqueeText) - 1 ? marqueeText[column] : ' ';
+	}
+	window[LCD_COLUMNS] = '\0';
+}
+
+static void bench_suite(uint8_t level, const char *levelName)
+{
+	bench_mark mark;
+	char window[LCD_COLUMNS + 1];
+	uint8_t row, step;
+
+	hd44780u_emuReset();
+	clk_set(level);
+
+	printf("\n%s\n", levelName);
+	printf("%-26s %8s %8s %9s %8s %7s %10s %10s\n", "operation", "pulses", "commands",
+		"writes", "reads", "busyviol", "bus us", "ready us");
+
+	mark = bench_start();
+	hd44780u_init();
+	bench_report("init", mark, 1);
+
+	mark = bench_start();
+	hd44780u_clear();
+	bench_report("clear", mark, 1);
+	bench_expect(0, "                ");
+
+	mark = bench_start();
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		hd44780u_gotoXY(0, row);
+		hd44780u_putString(rowText[row]);
+	}
+	bench_report("full screen write", mark, 1);
+	for(row = 0; row < LCD_ROWS; row++)
+		bench_expect(row, rowText[row]);
+
+	mark = bench_start();
+	hd44780u_gotoXY(5, 1);
+	hd44780u_write('X');
+	bench_report("single cell update", mark, 1);
+	bench_expect(1, "fedcbX9876543210");
+
+	/* marquee by rewriting visible row each step */
+	mark = bench_start();
+	for(step = 1; step <= MARQUEE_STEPS; step++)
+	{
+		uint8_t i;
+
+		bench_window(step, window);
+		hd44780u_gotoXY(0, 0);
+		for(i = 0; i < LCD_COLUMNS; i++)
+			hd44780u_write(window[i]);
+	}
+	bench_report("marquee step, rewrite", mark, MARQUEE_STEPS);
+	bench_expect(0, window);
+
+	mark = bench_start();
+	hd44780u_vlineLoad(marqueeLines, 1);
+	bench_report("virtual line load", mark, 1);
+	bench_window(0, window);
+	bench_expect(0, window);
+
+	mark = bench_start();
+	for(step = 1; step <= MARQUEE_STEPS; step++)
+	{
+		hd44780u_scrollLeft(marqueeLines, 1);
+		bench_window(step, window);
+		bench_expect(0, window);
+	}
+	bench_report("marquee step, shift", mark, MARQUEE_STEPS);
+
+	/* cursor addressing follows scrolled window */
+	hd44780u_gotoXY(0, 1);
+	hd44780u_write('Z');
+	hd44780u_emuRender(1, window);
+	if(window[0] != 'Z')
+	{
+		printf("  MISMATCH gotoXY after scroll: shown \"%s\"\n", window);
+		failures++;
+	}
+
+	mark = bench_start();
+	for(step = MARQUEE_STEPS; step > 0; step--)
+	{
+		hd44780u_scrollRight(marqueeLines, 1);
+		bench_window(step - 1, window);
+		bench_expect(0, window);
+	}
+	bench_report("marquee step back, shift", mark, MARQUEE_STEPS);
+}
+
+int main(void)
+{
+	bench_suite(CLK_NORMAL, "CLK_NORMAL (1 MHz)");
+	bench_suite(CLK_FAST, "CLK_FAST (8 MHz)");
+
+	if(failures)
+	{
+		printf("\n%u display mismatches\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
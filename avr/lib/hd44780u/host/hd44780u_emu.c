@@ -0,0 +1,362 @@
+#include <string.h>
+#include <avr/io.h>
+#include "hd44780u_emu.h"
+#include "../hd44780u.h"
+#include "../../clk/clk.h"
+
+static void hd44780u_emuSample(void);
+static void hd44780u_emuLatch(uint8_t rs, uint8_t byte);
+static void hd44780u_emuExecute(uint8_t command);
+static void hd44780u_emuStepAddress(void);
+static void hd44780u_emuShiftDisplay(uint8_t left);
+static uint8_t hd44780u_emuPinsToNibble(uint8_t pins);
+static uint8_t hd44780u_emuNibbleToPins(uint8_t nibble);
+
+/* MCU side */
+static volatile uint8_t emuRegs[3];
+static uint8_t emuLastEnable;
+
+/* controller state */
+static uint8_t ddram[0x80];
+static uint8_t cgram[0x40];
+static uint8_t addressCounter;
+static uint8_t cgramSelected;  //address counter points to CGRAM
+static uint8_t increment;      //entry mode I/D
+static uint8_t shiftOnWrite;   //entry mode S
+static uint8_t displayControl; //D C B bits
+static uint8_t eightBit;       //function set DL
+static uint8_t twoLine;        //function set N
+static uint8_t displayShift;   //DDRAM column shown at leftmost cell
+
+/* 4-bit interface state */
+static uint8_t secondNibble;
+static uint8_t highNibble;
+static uint8_t readLatch;
+static uint8_t busOutput;      //nibble driven by controller while reading
+
+static uint64_t nowNs;
+static uint64_t busyUntilNs;
+static hd44780u_emuStats stats;
+
+
+
+void hd44780u_emuReset(void)
+{
+	memset((void *)emuRegs, 0, sizeof(emuRegs));
+	emuLastEnable = 0;
+
+	memset(ddram, ' ', sizeof(ddram));
+	memset(cgram, 0, sizeof(cgram));
+	addressCounter = 0;
+	cgramSelected = 0;
+	increment = 1;
+	shiftOnWrite = 0;
+	displayControl = 0;
+	eightBit = 1;
+	twoLine = 0;
+	displayShift = 0;
+
+	secondNibble = 0;
+	highNibble = 0;
+	readLatch = 0;
+	busOutput = 0;
+
+	nowNs = 0;
+	busyUntilNs = HD44780U_EMU_RESET_NS;
+	memset(&stats, 0, sizeof(stats));
+}
+
+
+
+volatile uint8_t *hd44780u_emuRegister(uint8_t reg)
+{
+	hd44780u_emuSample();
+
+	stats.accesses++;
+	nowNs += HD44780U_EMU_ACCESS_CYCLES * (1000000000ULL / (CLK_F_MAX >> clk_get_shift()));
+
+	if(reg == HD44780U_EMU_PIND)
+	{
+		uint8_t ddr = emuRegs[HD44780U_EMU_DDRD];
+		uint8_t rw = (emuRegs[HD44780U_EMU_PORTD] & ddr & (1 << RW)) != 0;
+		uint8_t en = (emuRegs[HD44780U_EMU_PORTD] & ddr & (1 << EN)) != 0;
+		uint8_t pins = emuRegs[HD44780U_EMU_PORTD] & ddr;
+
+		if(rw && en)
+			pins |= hd44780u_emuNibbleToPins(busOutput) & ~ddr;
+
+		emuRegs[HD44780U_EMU_PIND] = pins;
+	}
+
+	return &emuRegs[reg];
+}
+
+
+
+void hd44780u_emuWaitUs(uint32_t us)
+{
+	hd44780u_emuSample();
+	nowNs += us * 1000ULL;
+}
+
+
+
+void hd44780u_emuWaitCycles(uint32_t cycles)
+{
+	hd44780u_emuSample();
+	nowNs += cycles * (1000000000ULL / (CLK_F_MAX >> clk_get_shift()));
+}
+
+
+
+uint64_t hd44780u_emuTimeNs(void)
+{
+	return nowNs;
+}
+
+
+
+uint64_t hd44780u_emuReadyNs(void)
+{
+	return busyUntilNs > nowNs ? busyUntilNs : nowNs;
+}
+
+
+
+hd44780u_emuStats hd44780u_emuGetStats(void)
+{
+	return stats;
+}
+
+
+
+void hd44780u_emuRender(uint8_t row, char *buffer)
+{
+	uint8_t column;
+
+	for(column = 0; column < LCD_COLUMNS; column++)
+	{
+		if(twoLine)
+			buffer[column] = ddram[(row ? 0x40 : 0x00) + (displayShift + column) % LCD_DDRAM_COLUMNS];
+		else
+			buffer[column] = row ? ' ' : ddram[(displayShift + column) % 80];
+	}
+	buffer[LCD_COLUMNS] = '\0';
+}
+
+
+
+uint8_t hd44780u_emuCgram(uint8_t addr)
+{
+	return cgram[addr & 0x3F];
+}
+
+
+
+/*
+* Function: hd44780u_emuSample
+* ----------------------------
+* Looks at lines driven by the MCU and reacts to enable edges.
+* Reads are set up on rising edge, writes are latched on falling edge.
+*/
+static void hd44780u_emuSample(void)
+{
+	uint8_t port = emuRegs[HD44780U_EMU_PORTD] & emuRegs[HD44780U_EMU_DDRD];
+	uint8_t en = (port & (1 << EN)) != 0;
+	uint8_t rs = (port & (1 << RS)) != 0;
+	uint8_t rw = (port & (1 << RW)) != 0;
+
+	if(en == emuLastEnable)
+		return;
+
+	emuLastEnable = en;
+
+	if(en)//rising edge
+	{
+		if(rw && (eightBit || !secondNibble))
+		{
+			if(rs)
+				readLatch = cgramSelected ? cgram[addressCounter & 0x3F] : ddram[addressCounter & 0x7F];
+			else
+				readLatch = ((nowNs < busyUntilNs) << 7) | (addressCounter & 0x7F);
+		}
+		busOutput = (eightBit || !secondNibble) ? (readLatch >> 4) : (readLatch & 0x0F);
+		return;
+	}
+
+	//falling edge
+	stats.transactions++;
+
+	if(rw)
+	{
+		if(!eightBit)
+			secondNibble ^= 1;
+
+		if(eightBit || !secondNibble)
+		{
+			stats.reads++;
+			if(rs)
+				hd44780u_emuStepAddress();
+		}
+		return;
+	}
+
+	if(eightBit)//D3-D0 of the module are not connected
+	{
+		hd44780u_emuLatch(rs, hd44780u_emuPinsToNibble(port) << 4);
+	}
+	else if(!secondNibble)
+	{
+		highNibble = hd44780u_emuPinsToNibble(port);
+		secondNibble = 1;
+	}
+	else
+	{
+		secondNibble = 0;
+		hd44780u_emuLatch(rs, (highNibble << 4) | hd44780u_emuPinsToNibble(port));
+	}
+}
+
+
+
+static void hd44780u_emuLatch(uint8_t rs, uint8_t byte)
+{
+	uint64_t execNs = HD44780U_EMU_EXEC_NS;
+
+	if(nowNs < busyUntilNs)
+		stats.busyViolations++;
+
+	if(rs)
+	{
+		stats.dataWrites++;
+		if(cgramSelected)
+			cgram[addressCounter & 0x3F] = byte;
+		else
+			ddram[addressCounter & 0x7F] = byte;
+
+		hd44780u_emuStepAddress();
+		if(shiftOnWrite && !cgramSelected)
+			hd44780u_emuShiftDisplay(increment);
+	}
+	else
+	{
+		stats.commands++;
+		if(byte == HD44780U_CLEAR || (byte & 0xFE) == HD44780U_RETURN_HOME)
+			execNs = HD44780U_EMU_EXEC_HOME_NS;
+		hd44780u_emuExecute(byte);
+	}
+
+	busyUntilNs = nowNs + execNs;
+}
+
+
+
+static void hd44780u_emuExecute(uint8_t command)
+{
+	if(command & 0x80)//set DDRAM address
+	{
+		addressCounter = command & 0x7F;
+		cgramSelected = 0;
+	}
+	else if(command & 0x40)//set CGRAM address
+	{
+		addressCounter = command & 0x3F;
+		cgramSelected = 1;
+	}
+	else if(command & 0x20)//function set
+	{
+		eightBit = (command & 0x10) != 0;
+		twoLine = (command & 0x08) != 0;
+		secondNibble = 0;
+	}
+	else if(command & 0x10)//cursor or display shift
+	{
+		if(command & 0x08)
+			hd44780u_emuShiftDisplay(!(command & 0x04));
+		else if(command & 0x04)
+			addressCounter++;
+		else
+			addressCounter--;
+	}
+	else if(command & 0x08)//display on/off control
+	{
+		displayControl = command & 0x07;
+	}
+	else if(command & 0x04)//entry mode set
+	{
+		increment = (command & 0x02) != 0;
+		shiftOnWrite = (command & 0x01) != 0;
+	}
+	else if(command & 0x02)//return home
+	{
+		addressCounter = 0;
+		cgramSelected = 0;
+		displayShift = 0;
+	}
+	else if(command & 0x01)//clear display
+	{
+		memset(ddram, ' ', sizeof(ddram));
+		addressCounter = 0;
+		cgramSelected = 0;
+		displayShift = 0;
+		increment = 1;
+	}
+}
+
+
+
+static void hd44780u_emuStepAddress(void)
+{
+	if(cgramSelected)
+	{
+		addressCounter = (addressCounter + (increment ? 1 : -1)) & 0x3F;
+	}
+	else if(twoLine)//lines at 0x00-0x27 and 0x40-0x67
+	{
+		if(increment)
+			addressCounter = addressCounter == 0x27 ? 0x40 : addressCounter == 0x67 ? 0x00 : addressCounter + 1;
+		else
+			addressCounter = addressCounter == 0x40 ? 0x27 : addressCounter == 0x00 ? 0x67 : addressCounter - 1;
+	}
+	else//single line at 0x00-0x4F
+	{
+		addressCounter = increment ? (addressCounter + 1) % 80 : (addressCounter + 79) % 80;
+	}
+}
+
+
+
+static void hd44780u_emuShiftDisplay(uint8_t left)
+{
+	uint8_t columns = twoLine ? LCD_DDRAM_COLUMNS : 80;
+
+	displayShift = left ? (displayShift + 1) % columns : (displayShift + columns - 1) % columns;
+}
+
+
+
+static uint8_t hd44780u_emuPinsToNibble(uint8_t pins)
+{
+	uint8_t nibble = 0;
+
+	if(pins & (1 << D0)) nibble |= 0x01;
+	if(pins & (1 << D1)) nibble |= 0x02;
+	if(pins & (1 << D2)) nibble |= 0x04;
+	if(pins & (1 << D3)) nibble |= 0x08;
+
+	return nibble;
+}
+
+
+
+static uint8_t hd44780u_emuNibbleToPins(uint8_t nibble)
+{
+	uint8_t pins = 0;
+
+	if(nibble & 0x01) pins |= (1 << D0);
+	if(nibble & 0x02) pins |= (1 << D1);
+	if(nibble & 0x04) pins |= (1 << D2);
+	if(nibble & 0x08) pins |= (1 << D3);
+
+	return pins;
+}
@@ -0,0 +1,104 @@
+#ifndef HD44780U_EMU_H_
+#define HD44780U_EMU_H_
+
+#include <stdint.h>
+
+/******************THIS BLOCK DEFINE HOW EMULATOR SHOULD OPERATE***************************/
+/* Execution times from HD44780U datasheet Table 6, fosc 270 kHz */
+#define HD44780U_EMU_EXEC_NS       37000UL   // most instructions and RAM writes
+#define HD44780U_EMU_EXEC_HOME_NS  1520000UL // clear display, return home
+#define HD44780U_EMU_RESET_NS      10000000UL // busy after power on, internal reset
+
+/* MCU cost of one port register access, in/and/out sequence */
+#define HD44780U_EMU_ACCESS_CYCLES 3
+
+/* MCU cost of a clk_delay_us/clk_delay_ms call on top of the wait,
+   call/ret, 32-bit multiply and variable shift */
+#define HD44780U_EMU_DELAY_CALL_CYCLES 40
+
+/* emulated port registers */
+#define HD44780U_EMU_DDRD  0
+#define HD44780U_EMU_PORTD 1
+#define HD44780U_EMU_PIND  2
+/****************************************************************************************/
+
+/* bus statistics, see hd44780u_emuStats */
+typedef struct
+{
+	uint32_t accesses;        // MCU port register accesses
+	uint32_t transactions;    // enable pulses
+	uint32_t commands;        // instructions executed
+	uint32_t dataWrites;      // CGRAM/DDRAM writes
+	uint32_t reads;           // busy flag/address and data reads
+	uint32_t busyViolations;  // instructions or writes latched while busy
+} hd44780u_emuStats;
+
+/*
+* Function: hd44780u_emuReset
+* ----------------------------
+* Powers on emulated module: 8-bit interface, display off, DDRAM filled with spaces.
+* Modeled time and statistics restart from zero.
+*/
+void hd44780u_emuReset(void);
+
+/*
+* Function: hd44780u_emuRegister
+* ----------------------------
+* Backs host avr/io.h port registers. Samples bus state left by previous access,
+* charges access time and returns the register to be read or written.
+* reg: HD44780U_EMU_DDRD, HD44780U_EMU_PORTD or HD44780U_EMU_PIND.
+*/
+volatile uint8_t *hd44780u_emuRegister(uint8_t reg);
+
+/*
+* Function: hd44780u_emuWaitUs
+* ----------------------------
+* Advances modeled time, used by host clk_delay_us.
+*/
+void hd44780u_emuWaitUs(uint32_t us);
+
+/*
+* Function: hd44780u_emuWaitCycles
+* ----------------------------
+* Advances modeled time by MCU cycles at current clock, used by inline cycle delays.
+*/
+void hd44780u_emuWaitCycles(uint32_t cycles);
+
+/*
+* Function: hd44780u_emuTimeNs
+* ----------------------------
+* returns: modeled time since hd44780u_emuReset.
+*/
+uint64_t hd44780u_emuTimeNs(void);
+
+/*
+* Function: hd44780u_emuReadyNs
+* ----------------------------
+* returns: modeled time at which current instruction finishes executing.
+*/
+uint64_t hd44780u_emuReadyNs(void);
+
+/*
+* Function: hd44780u_emuGetStats
+* ----------------------------
+* returns: bus statistics since hd44780u_emuReset.
+*/
+hd44780u_emuStats hd44780u_emuGetStats(void);
+
+/*
+* Function: hd44780u_emuRender
+* ----------------------------
+* Copies visible characters of a row, display shift applied.
+* row: lcd row.
+* buffer: LCD_COLUMNS characters + null terminator.
+*/
+void hd44780u_emuRender(uint8_t row, char *buffer);
+
+/*
+* Function: hd44780u_emuCgram
+* ----------------------------
+* returns: CGRAM byte at given address.
+*/
+uint8_t hd44780u_emuCgram(uint8_t addr);
+
+#endif //HD44780U_EMU_H_
@@ -0,0 +1,16 @@
+#ifndef HD44780U_HOST_IO_H_
+#define HD44780U_HOST_IO_H_
+
+/* Host replacement for avr/io.h, LCD port registers map to emulated HD44780U */
+#include <stdint.h>
+#include "hd44780u_emu.h"
+
+#define DDRD  (*hd44780u_emuRegister(HD44780U_EMU_DDRD))
+#define PORTD (*hd44780u_emuRegister(HD44780U_EMU_PORTD))
+#define PIND  (*hd44780u_emuRegister(HD44780U_EMU_PIND))
+
+/* clock prescaler is owned by host clk stub, cycle delays advance modeled time */
+extern volatile uint8_t CLKPR;
+#define __builtin_avr_delay_cycles(cycles) hd44780u_emuWaitCycles(cycles)
+
+#endif //HD44780U_HOST_IO_H_
@@ -0,0 +1,11 @@
+#ifndef HD44780U_HOST_PGMSPACE_H_
+#define HD44780U_HOST_PGMSPACE_H_
+
+/* Host replacement for avr/pgmspace.h, program memory is ordinary memory */
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+#endif //HD44780U_HOST_PGMSPACE_H_
@@ -0,0 +1,257 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "../clk/clk.h"
+#include "sched.h"
+
+/* software timer, inactive when task is 0 */
+typedef struct
+{
+	uint16_t deadline;
+	uint16_t period;
+	sched_task_cb task;
+} sched_timer;
+
+/* scheduler private function declarations*/
+static sched_task_cb sched_pop(void); //take next queued task, 0 if queue is empty
+static void sched_expire_timers(void); //queue tasks of expired timers once per tick
+static inline void sched_sleep(void); //sleep until next interrupt
+
+/*scheduler global variables*/
+static volatile uint16_t sched_tick; //incremented by Timer0 compare A
+static volatile uint8_t sched_wake; //set by Timer0 compare B at end of sched_idle_us
+static uint8_t sched_started;
+static uint16_t sched_last_tick; //last tick timers were checked at
+
+static sched_task_cb sched_queue[SCHED_QUEUE_SIZE];
+static volatile uint8_t sched_head, sched_tail; //free running queue indexes
+
+static sched_timer sched_timer_list[SCHED_TIMERS];
+
+
+
+ISR(TIMER0_COMPA_vect)
+{
+	sched_tick++;
+}
+
+
+
+ISR(TIMER0_COMPB_vect)
+{
+	sched_wake = 1;
+}
+
+
+
+void sched_init(void)
+{
+	TCCR0A = (1 << WGM01); //CTC mode, TOP = OCR0A
+	OCR0A = SCHED_TICK_COUNTS - 1;
+	TCNT0 = 0;
+	SCHED_TIFR = (1 << OCF0A) | (1 << OCF0B); //clear pending compare flags
+	SCHED_TIMSK |= (1 << OCIE0A); //tick interrupt
+
+	set_sleep_mode(SLEEP_MODE_IDLE); //timer0 keeps running in idle mode
+	sched_started = 1;
+
+	TCCR0B = clk_timer_cs(); //start timer0
+	sei();
+}
+
+
+
+void sched_run(void)
+{
+	sched_task_cb task;
+
+	for(;;)
+	{
+		sched_expire_timers();
+
+		task = sched_pop();
+		if(task)
+		{
+			task(); //run to completion
+			continue;
+		}
+
+		/* nothing to do, sleep unless an interrupt queued work meanwhile */
+		cli();
+		if(sched_head == sched_tail && sched_tick == sched_last_tick)
+		{
+			sched_sleep();
+		}
+		sei();
+	}
+}
+
+
+
+uint8_t sched_post(sched_task_cb task)
+{
+	uint8_t sreg = SREG;
+	uint8_t queued = 0;
+
+	cli();
+	if((uint8_t)(sched_head - sched_tail) < SCHED_QUEUE_SIZE)
+	{
+		sched_queue[sched_head & (SCHED_QUEUE_SIZE - 1)] = task;
+		sched_head++;
+		queued = 1;
+	}
+	SREG = sreg;
+
+	return queued;
+}
+
+
+
+uint16_t sched_ticks(void)
+{
+	uint16_t ticks;
+	uint8_t sreg = SREG;
+
+	cli();
+	ticks = sched_tick;
+	SREG = sreg;
+
+	return ticks;
+}
+
+
+
+void sched_timer_start(uint8_t id, uint16_t ticks, uint16_t period, sched_task_cb task)
+{
+	sched_timer *timer = &sched_timer_list[id];
+
+	timer->deadline = sched_ticks() + ticks;
+	timer->period = period;
+	timer->task = task;
+}
+
+
+
+void sched_timer_stop(uint8_t id)
+{
+	sched_timer_list[id].task = 0;
+}
+
+
+
+void sched_idle_us(uint16_t us)
+{
+	uint16_t start, ticks, counts;
+	uint8_t remainder;
+
+	if(!sched_started || !(SREG & (1 << SREG_I)) || us < SCHED_IDLE_MIN_US)
+	{
+		clk_delay_us(us);
+		return;
+	}
+
+	/* wait end as tick + timer count */
+	cli();
+	start = sched_tick;
+	counts = TCNT0;
+	if(SCHED_TIFR & (1 << OCF0A)) //timer wrapped, tick interrupt still pending
+	{
+		start++;
+		counts = TCNT0;
+	}
+
+	counts += (us + SCHED_US_PER_COUNT - 1) / SCHED_US_PER_COUNT + 1; //round up, TCNT0 count already partly elapsed
+	ticks = counts / SCHED_TICK_COUNTS;
+	remainder = counts % SCHED_TICK_COUNTS;
+
+	/* whole ticks */
+	while((uint16_t)(sched_tick - start) < ticks)
+	{
+		sched_sleep();
+	}
+
+	/* rest of the last tick, woken by compare B */
+	if((uint16_t)(sched_tick - start) == ticks && TCNT0 < remainder)
+	{
+		OCR0B = remainder;
+		sched_wake = 0;
+		SCHED_TIFR = (1 << OCF0B);
+		SCHED_TIMSK |= (1 << OCIE0B);
+
+		while(!sched_wake && (uint16_t)(sched_tick - start) == ticks)
+		{
+			sched_sleep();
+		}
+
+		SCHED_TIMSK &= ~(1 << OCIE0B);
+	}
+	sei();
+}
+
+
+
+void sched_idle_ms(uint16_t ms)
+{
+	while(ms--)
+	{
+		sched_idle_us(1000);
+	}
+}
+
+
+
+static sched_task_cb sched_pop(void)
+{
+	sched_task_cb task = 0;
+	uint8_t sreg = SREG;
+
+	cli();
+	if(sched_head != sched_tail)
+	{
+		task = sched_queue[sched_tail & (SCHED_QUEUE_SIZE - 1)];
+		sched_tail++;
+	}
+	SREG = sreg;
+
+	return task;
+}
+
+
+
+static void sched_expire_timers(void)
+{
+	uint16_t now = sched_ticks();
+	sched_timer *timer = sched_timer_list;
+	uint8_t i;
+
+	if(now == sched_last_tick)
+		return;
+
+	sched_last_tick = now;
+
+	for(i = 0; i < SCHED_TIMERS; i++, timer++)
+	{
+		if(timer->task && (int16_t)(now - timer->deadline) >= 0)
+		{
+			sched_post(timer->task);
+
+			if(timer->period)
+				timer->deadline += timer->period; //periodic, keep phase
+			else
+				timer->task = 0; //one-shot
+		}
+	}
+}
+
+
+
+/* Must be called with interrupts disabled, returns with interrupts disabled.
+   sei before sleep takes effect after the sleep instruction so no wake up is lost. */
+static inline void sched_sleep(void)
+{
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	cli();
+}
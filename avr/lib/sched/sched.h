@@ -0,0 +1,48 @@
+#ifndef SCHED_H_
+#define SCHED_H_
+
+/******************THIS BLOCK DEFINE HOW SCHEDULER SHOULD OPERATE***************************/
+/* Timer0 tick settings, CTC mode. Timer0 counts at CLK_TIMER_HZ on every clock level,
+   1 ms tick: 125000 / 125 */
+#define SCHED_TICK_COUNTS    125          // timer counts per tick
+#define SCHED_US_PER_COUNT   (1000000UL / CLK_TIMER_HZ)
+#define SCHED_TICK_US        (SCHED_TICK_COUNTS * SCHED_US_PER_COUNT)
+
+#define SCHED_QUEUE_SIZE     8   // task queue length, power of two
+#define SCHED_TIMERS         4   // number of software timers
+#define SCHED_IDLE_MIN_US    32  // shorter waits busy loop, sleep wake up would take longer
+
+/* Timer0 interrupt registers differ between tiny and mega parts */
+#ifdef TIMSK0
+#define SCHED_TIMSK TIMSK0
+#define SCHED_TIFR  TIFR0
+#else
+#define SCHED_TIMSK TIMSK
+#define SCHED_TIFR  TIFR
+#endif
+
+/* Task callback. Tasks run to completion from sched_run. */
+typedef void (*sched_task_cb)(void);
+/****************************************************************************************/
+
+
+/*--------scheduler function declarations--------*/
+extern void sched_init(void); //start Timer0 tick, enables interrupts
+extern void sched_run(void); //run queued tasks and timers, sleep when idle. Never returns.
+extern uint8_t sched_post(sched_task_cb task); //queue task, safe from ISR. returns 0 if queue full
+extern uint16_t sched_ticks(void); //ticks since sched_init, wraps around
+
+/* start software timer id, task is queued after ticks and then every period ticks.
+   period 0 makes one-shot timer. Deadlines must be below 32768 ticks. */
+extern void sched_timer_start(uint8_t id, uint16_t ticks, uint16_t period, sched_task_cb task);
+extern void sched_timer_stop(uint8_t id); //cancel software timer id
+
+/* Drivers use these instead of busy-wait delays. The cpu sleeps until the wait is over,
+   interrupts keep being served. Busy loops before sched_init or with interrupts disabled.
+   These do not yield: the calling task keeps the queue and no other task runs until it
+   returns, so a task's length includes its driver waits. Split long driver work into
+   several tasks where latency matters, e.g. one LCD row per task with TDMA. */
+extern void sched_idle_us(uint16_t us); //wait microseconds
+extern void sched_idle_ms(uint16_t ms); //wait milliseconds
+
+#endif /* SCHED_H_ */